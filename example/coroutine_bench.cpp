@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <chrono>
+#include <event/coroutine.hpp>
+#include <common/log.hpp>
+
+/// The number of timer hops of each benchmark
+#define BENCH_HOPS 1000000
+
+#if defined(__cpp_impl_coroutine)
+
+class HopTimerCb: public event::Callback<event::TimerEvent> {
+ public:
+    HopTimerCb(event::TimerBus *bus, u32 *count): bus(bus), count(count) {}
+
+    void onEvent(event::TimerEvent *e) const override {
+        if (++*count < BENCH_HOPS) {
+            e->setTimeout(0);
+            bus->addEvent(e, this);
+        }
+    }
+
+ private:
+    event::TimerBus *bus;
+    u32 *count;
+};
+
+static event::Task hop(event::TimerBus *bus, u32 *count) {
+    while (*count < BENCH_HOPS) {
+        co_await event::sleep(bus, 0);
+        ++*count;
+    }
+}
+
+/// Run the bus until all hops are done, return the nanoseconds per hop
+static double run(event::TimerBus *bus, const u32 *count) {
+    auto begin = std::chrono::steady_clock::now();
+    while (*count < BENCH_HOPS) {
+        bus->dispatch();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+        BENCH_HOPS;
+}
+
+/// The main entry of the app
+int app_main(int argc, char *argv[]) {
+    event::TimerBus callbackBus;
+    event::TimerEvent e;
+    u32 callbackCount = 0;
+    HopTimerCb cb(&callbackBus, &callbackCount);
+
+    e.setTimeout(0);
+    callbackBus.addEvent(&e, &cb);
+    log_info("callback: %.1f ns/hop", run(&callbackBus, &callbackCount));
+
+    event::TimerBus coroutineBus;
+    u32 coroutineCount = 0;
+
+    hop(&coroutineBus, &coroutineCount);
+    log_info("coroutine: %.1f ns/hop", run(&coroutineBus, &coroutineCount));
+    return 0;
+}
+
+#else
+
+/// The main entry of the app
+int app_main(int argc, char *argv[]) {
+    log_err("coroutines are not supported, build with -std=c++20");
+    return 0;
+}
+
+#endif  // __cpp_impl_coroutine
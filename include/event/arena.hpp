@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <platform/type.hpp>
+
+/**
+ * @file arena.hpp
+ * @brief Class Arena
+*/
+
+#define ARENA_SLAB_SIZE 16384U
+#define ARENA_CLASS_NUM 6
+
+/// The largest alignment of the objects, the slabs are aligned to it
+#define ARENA_ALIGN_MAX 64U
+
+namespace event {
+
+/**
+ * @brief Allocate the events and callbacks of a loop from slabs
+ *
+ * The objects are allocated from size-classed slabs with free lists
+ * owned by the arena, the arena is not thread-safe and should only
+ * be used from the thread running the loop. Objects created in a
+ * @c Group are destroyed together when the group is released.
+*/
+class Arena {
+ private:
+    struct Block {
+        Block *prev;
+        Block *next;
+        void (*dtor)(void *);
+        u32 cls;
+        u32 offset;  ///< Offset of the header from the start of the memory
+    };
+
+ public:
+    /**
+     * @brief A set of objects released together, such as the events of a connection
+    */
+    class Group {
+     public:
+        /**
+         * @brief Default constructor
+         *
+         * @param arena is the arena to allocate from
+        */
+        explicit Group(Arena *arena): arena(arena) {
+            head.prev = head.next = &head;
+        }
+
+
+        /**
+         * @brief Release the objects of the group
+        */
+        ~Group() {
+            release();
+        }
+
+
+        /**
+         * @brief Destroy all the objects of the group, in the reverse order of creation
+        */
+        void release();
+
+     private:
+        friend class Arena;
+
+        Arena *arena;
+        Block head;
+    };
+
+    /**
+     * @brief Default constructor
+    */
+    Arena();
+
+
+    /**
+     * @brief Free the slabs, the objects must have been destroyed
+    */
+    ~Arena();
+
+
+    /**
+     * @brief Create an object, aligned up to ARENA_ALIGN_MAX
+     *
+     * @param group is the group of the object, nullptr if the object is destroyed alone
+     * @param args are the arguments of the constructor
+     *
+     * @return a pointer to the object
+    */
+    template <class T, class... Args>
+    T *create(Group *group, Args&&... args) {
+        static_assert(alignof(T) <= ARENA_ALIGN_MAX,
+            "Arena: the alignment of the object is too large");
+        Block *b = alloc(sizeof(T), alignof(T));
+        T *obj;
+        try {
+            obj = new(data(b)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            free(b);
+            throw;
+        }
+        b->dtor = [] (void *p) {
+            static_cast<T *>(p)->~T();
+        };
+        if (group) {
+            link(&group->head, b);
+        }
+        return obj;
+    }
+
+
+    /**
+     * @brief Destroy an object, it is removed from its group
+     *
+     * A polymorphic object may be passed by a pointer to any of its bases,
+     * other objects must be passed by a pointer to the type created.
+     *
+     * @param obj is a pointer to the object
+    */
+    template <class T>
+    void destroy(T *obj) {
+        Block *b = block(top(obj, std::is_polymorphic<T>()));
+        unlink(b);
+        b->dtor(data(b));
+        free(b);
+    }
+
+ private:
+    /// Size of the block header, the header is placed right before the object
+    static const size_t HEADER_SIZE = sizeof(Block);
+
+    static void *data(Block *b) {
+        return reinterpret_cast<char *>(b) + HEADER_SIZE;
+    }
+
+    /// Get the most derived object of a polymorphic object
+    template <class T>
+    static void *top(T *obj, std::true_type) {
+        return const_cast<void *>(dynamic_cast<const volatile void *>(obj));
+    }
+
+    template <class T>
+    static void *top(T *obj, std::false_type) {
+        return const_cast<void *>(static_cast<const volatile void *>(obj));
+    }
+
+    static Block *block(void *p) {
+        return reinterpret_cast<Block *>(static_cast<char *>(p) - HEADER_SIZE);
+    }
+
+    static void link(Block *head, Block *b) {
+        b->prev = head->prev;
+        b->next = head;
+        head->prev->next = b;
+        head->prev = b;
+    }
+
+    static void unlink(Block *b) {
+        b->prev->next = b->next;
+        b->next->prev = b->prev;
+        b->prev = b->next = b;
+    }
+
+    Block *alloc(size_t size, size_t align);
+    void free(Block *b);
+
+    Block *freeList[ARENA_CLASS_NUM];
+    std::vector<void *> slabs;
+};
+
+}  // namespace event
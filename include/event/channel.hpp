@@ -0,0 +1,229 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+#include <event/event.hpp>
+#include <event/bus.hpp>
+#include <event/handle_event.hpp>
+
+/**
+ * @file channel.hpp
+ * @brief Channel interfaces
+*/
+
+#define CHANNEL_CACHE_LINE 64
+
+namespace event {
+
+/**
+ * @brief Base class of the channels, triggered in the receiver loop when messages are sent
+ *
+ * The sender writes the eventfd of the channel only when the receiver
+ * is waiting, a receiver which is draining the channel is not notified.
+*/
+class ChannelEvent: public Event {
+ public:
+    /**
+     * @brief Default constructor, create the eventfd
+    */
+    ChannelEvent();
+
+
+    /**
+     * @brief Close the eventfd
+    */
+    virtual ~ChannelEvent();
+
+
+    /**
+     * @brief Whether the channel has no message
+     *
+     * @return true if the channel is empty
+    */
+    virtual bool isEmpty() const = 0;
+
+ protected:
+    /**
+     * @brief Called by the sender after a message was queued
+    */
+    void notify() {
+        if (waiting.load() && waiting.exchange(false)) {
+            wakeup();
+        }
+    }
+
+
+    /**
+     * @brief Called by the receiver when the channel was found empty
+    */
+    void wait() {
+        waiting.store(true);
+    }
+
+ private:
+    friend class ChannelBus;
+
+    void wakeup();
+    void clear();
+
+    std::atomic<bool> waiting;
+    platform::Handle *handle;
+};
+
+typedef common::ObjectException<ChannelEvent> ChannelEventException;
+
+/**
+ * @brief A bounded lock-free channel with a single sender and a single receiver
+ *
+ * Messages must be sent from a single sender thread and are received
+ * in the callback of the channel event, which should drain them with @c recv().
+*/
+template <class T>
+class Channel: public ChannelEvent {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param capacity is the number of messages, rounded up to a power of 2
+    */
+    explicit Channel(u32 capacity): head(0), tail(0), headCache(0) {
+        u32 size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        ring.resize(size);
+        mask = size - 1;
+    }
+
+
+    /**
+     * @brief Empty virtual destructor
+    */
+    virtual ~Channel() {}
+
+
+    /**
+     * @brief Send a message, called by the sender only
+     *
+     * @param msg is the message
+     *
+     * @return false if the channel is full
+    */
+    bool send(T msg) {
+        u32 t = tail.load(std::memory_order_relaxed);
+        if (t - headCache > mask) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache > mask) {
+                return false;
+            }
+        }
+        ring[t & mask] = std::move(msg);
+        tail.store(t + 1);
+        notify();
+        return true;
+    }
+
+
+    /**
+     * @brief Receive a message, called by the receiver only
+     *
+     * @param msg is a pointer to the message
+     *
+     * @return false if the channel is empty
+    */
+    bool recv(T *msg) {
+        u32 h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            wait();
+            if (h == tail.load()) {
+                return false;
+            }
+        }
+        *msg = std::move(ring[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    /**
+     * @brief Override to check if the channel is empty
+    */
+    bool isEmpty() const override {
+        return head.load(std::memory_order_relaxed) ==
+            tail.load(std::memory_order_acquire);
+    }
+
+ private:
+    std::vector<T> ring;
+    u32 mask;
+    alignas(CHANNEL_CACHE_LINE) std::atomic<u32> head;
+    alignas(CHANNEL_CACHE_LINE) std::atomic<u32> tail;
+    u32 headCache;
+};
+
+/**
+ * @brief Bus of the channel events, the eventfds are polled in the handle bus of the receiver
+*/
+class ChannelBus: public Bus<ChannelEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param bus is the handle bus of the receiver loop
+    */
+    explicit ChannelBus(HandleBus *bus);
+
+
+    /**
+     * @brief Delete the channels from the handle bus
+    */
+    ~ChannelBus() override;
+
+
+    /**
+     * @brief Override to add a channel event to the channel bus
+    */
+    void addEvent(ChannelEvent *e, const Callback<ChannelEvent> *cb) override;
+
+
+    /**
+     * @brief Override to delete a channel event from the channel bus
+    */
+    void delEvent(ChannelEvent *e) override;
+
+ private:
+    class ChannelNode;
+    class Receiver;
+
+    ChannelNode *find(ChannelEvent *e);
+    void remove(ChannelNode *node);
+    void onReadable(ChannelNode *node);
+
+    HandleBus *bus;
+    Receiver *receiver;
+    ChannelNode *channelHead;
+};
+
+}  // namespace event
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <sys/types.h>
+#include <event/event.hpp>
+#include <event/bus.hpp>
+#include <event/handle_event.hpp>
+
+/**
+ * @file child_event.hpp
+ * @brief Child process event interfaces
+*/
+
+namespace event {
+
+/**
+ * @brief Triggered once when the child process exits, the child is reaped by the bus
+*/
+class ChildEvent: public Event {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param pid is the process ID of the child
+    */
+    explicit ChildEvent(pid_t pid): pid(pid), code(0), status(0) {}
+
+
+    /**
+     * @brief Empty virtual destructor
+    */
+    virtual ~ChildEvent() {}
+
+
+    /**
+     * @brief Get the process ID of the child
+     *
+     * @return the process ID
+    */
+    pid_t getPid() const {
+        return pid;
+    }
+
+
+    /**
+     * @brief Get how the child exited
+     *
+     * @return CLD_EXITED, CLD_KILLED or CLD_DUMPED
+    */
+    int getCode() const {
+        return code;
+    }
+
+
+    /**
+     * @brief Get the exit status or the signal that killed the child
+     *
+     * @return the status, see @c getCode()
+    */
+    int getStatus() const {
+        return status;
+    }
+
+ private:
+    friend class ChildBus;
+
+    pid_t pid;
+    int code;
+    int status;
+};
+
+typedef common::ObjectException<ChildEvent> ChildEventException;
+
+/**
+ * @brief Bus of the child events, each child is watched with a pidfd in the handle bus
+*/
+class ChildBus: public Bus<ChildEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param bus is the handle bus to poll the pidfds
+    */
+    explicit ChildBus(HandleBus *bus);
+
+
+    /**
+     * @brief Close the pidfds of the children still watched
+    */
+    ~ChildBus() override;
+
+
+    /**
+     * @brief Override to add a child event to the child bus
+    */
+    void addEvent(ChildEvent *e, const Callback<ChildEvent> *cb) override;
+
+
+    /**
+     * @brief Override to delete a child event from the child bus
+    */
+    void delEvent(ChildEvent *e) override;
+
+ private:
+    class ChildNode;
+    class Reaper;
+
+    void remove(ChildNode *node);
+    void onExited(ChildNode *node);
+
+    HandleBus *bus;
+    Reaper *reaper;
+    ChildNode *childHead;
+};
+
+}  // namespace event
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <platform/type.hpp>
+#include <platform/clock.hpp>
+
+/**
+ * @file clock.hpp
+ * @brief Clock interfaces
+*/
+
+namespace event {
+
+/**
+ * @brief Base clock class, the timer bus reads the time from it
+*/
+class Clock {
+ public:
+    /**
+     * @brief Empty virtual destructor
+    */
+    virtual ~Clock() {}
+
+
+    /**
+     * @brief Get the current time
+     *
+     * @return the time as the number of milliseconds
+    */
+    virtual u64 getTotalMs() = 0;
+
+
+    /**
+     * @brief Whether the time only advances when asked to
+     *
+     * @return true if the clock is virtual
+    */
+    virtual bool isVirtual() const {
+        return false;
+    }
+
+
+    /**
+     * @brief Advance the time, the time of a real clock advances by itself
+     *
+     * @param ms is the number of milliseconds
+    */
+    virtual void advance(u64 ms) {
+        (void)ms;
+    }
+};
+
+/**
+ * @brief The clock of the platform
+*/
+class SystemClock: public Clock {
+ public:
+    /**
+     * @brief Get the instance of the system clock
+    */
+    static SystemClock &Instance() {
+        static SystemClock clock;
+        return clock;
+    }
+
+    u64 getTotalMs() override {
+        return platform::Clock::Instance().getTotalMs();
+    }
+};
+
+/**
+ * @brief A clock advanced by hand, the loop advances it to the next timer instead of waiting
+*/
+class VirtualClock: public Clock {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param ms is the initial time in milliseconds
+    */
+    explicit VirtualClock(u64 ms = 0): ms(ms) {}
+
+    u64 getTotalMs() override {
+        return ms;
+    }
+
+    bool isVirtual() const override {
+        return true;
+    }
+
+
+    void advance(u64 ms) override {
+        this->ms += ms;
+    }
+
+
+    /**
+     * @brief Set the time, it should not go backwards while timers are added
+     *
+     * @param ms is the time in milliseconds
+    */
+    void setTotalMs(u64 ms) {
+        this->ms = ms;
+    }
+
+ private:
+    u64 ms;
+};
+
+}  // namespace event
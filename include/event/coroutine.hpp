@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <event/loop.hpp>
+
+/**
+ * @file coroutine.hpp
+ * @brief C++20 coroutine interfaces
+ *
+ * The awaiters live in the coroutine frame and are resumed inline from
+ * the dispatch of the bus. The timer and handle events are embedded in
+ * the awaiters and linked into the buses without allocating, so no memory
+ * is allocated except the frame itself.
+*/
+
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+
+namespace event {
+
+/**
+ * @brief A detached coroutine, it starts immediately and frees its frame when finished
+*/
+class Task {
+ public:
+    struct promise_type {
+        Task get_return_object() { return Task(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Awaiter resumed after a delay
+*/
+class SleepAwaiter: public Callback<TimerEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param bus is the timer bus
+     * @param ms is the delay in milliseconds
+    */
+    SleepAwaiter(TimerBus *bus, u32 ms): bus(bus), ms(ms) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        this->h = h;
+        e.setTimeout(ms);
+        bus->addEvent(&e, this);
+    }
+
+    void await_resume() const noexcept {}
+
+    void onEvent(TimerEvent *) const override {
+        h.resume();
+    }
+
+ private:
+    TimerBus *bus;
+    u32 ms;
+    TimerEvent e;
+    std::coroutine_handle<> h;
+};
+
+/**
+ * @brief Awaiter resumed when the handle is ready or the timeout expires
+*/
+class HandleAwaiter: public Callback<HandleEvent>, public Callback<TimerEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param bus is the handle bus
+     * @param handle A point to the handle
+     * @param op The operation to wait for
+    */
+    HandleAwaiter(HandleBus *bus, platform::Handle *handle,
+        HandleEvent::Operation op):
+        handleBus(bus), timerBus(nullptr), timeoutMs(0),
+        e(handle, op), ready(false) {}
+
+
+    /**
+     * @brief Constructor with a timeout
+     *
+     * @param loop is the loop to wait in
+     * @param handle A point to the handle
+     * @param op The operation to wait for
+     * @param ms is the timeout in milliseconds
+    */
+    HandleAwaiter(Loop *loop, platform::Handle *handle,
+        HandleEvent::Operation op, u32 ms):
+        handleBus(loop), timerBus(loop), timeoutMs(ms),
+        e(handle, op), ready(false) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        this->h = h;
+        handleBus->addEvent(&e, this);
+        if (timerBus) {
+            timer.setTimeout(timeoutMs);
+            timerBus->addEvent(&timer, this);
+        }
+    }
+
+    /**
+     * @return true if the handle is ready, false if the timeout expired
+    */
+    bool await_resume() const noexcept {
+        return ready;
+    }
+
+    void onEvent(HandleEvent *) const override {
+        handleBus->delEvent(&e);
+        if (timerBus) {
+            timerBus->delEvent(&timer);
+        }
+        ready = true;
+        h.resume();
+    }
+
+    void onEvent(TimerEvent *) const override {
+        handleBus->delEvent(&e);
+        h.resume();
+    }
+
+ private:
+    HandleBus *handleBus;
+    TimerBus *timerBus;
+    u32 timeoutMs;
+    mutable HandleEvent e;
+    mutable TimerEvent timer;
+    mutable bool ready;
+    std::coroutine_handle<> h;
+};
+
+/**
+ * @brief Suspend the coroutine for a delay
+ *
+ * @param bus is the timer bus
+ * @param ms is the delay in milliseconds
+*/
+inline SleepAwaiter sleep(TimerBus *bus, u32 ms) {
+    return SleepAwaiter(bus, ms);
+}
+
+/**
+ * @brief Suspend the coroutine until the handle is readable
+ *
+ * @param bus is the handle bus
+ * @param handle A point to the handle
+*/
+inline HandleAwaiter readable(HandleBus *bus, platform::Handle *handle) {
+    return HandleAwaiter(bus, handle, HandleEvent::OP_READ);
+}
+
+/**
+ * @brief Suspend the coroutine until the handle is writable
+ *
+ * @param bus is the handle bus
+ * @param handle A point to the handle
+*/
+inline HandleAwaiter writable(HandleBus *bus, platform::Handle *handle) {
+    return HandleAwaiter(bus, handle, HandleEvent::OP_WRITE);
+}
+
+/**
+ * @brief Suspend the coroutine until the handle is readable or the timeout expires
+ *
+ * @param loop is the loop to wait in
+ * @param handle A point to the handle
+ * @param ms is the timeout in milliseconds
+*/
+inline HandleAwaiter readable(Loop *loop, platform::Handle *handle, u32 ms) {
+    return HandleAwaiter(loop, handle, HandleEvent::OP_READ, ms);
+}
+
+/**
+ * @brief Suspend the coroutine until the handle is writable or the timeout expires
+ *
+ * @param loop is the loop to wait in
+ * @param handle A point to the handle
+ * @param ms is the timeout in milliseconds
+*/
+inline HandleAwaiter writable(Loop *loop, platform::Handle *handle, u32 ms) {
+    return HandleAwaiter(loop, handle, HandleEvent::OP_WRITE, ms);
+}
+
+}  // namespace event
+
+#endif  // __cpp_impl_coroutine
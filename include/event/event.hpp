@@ -38,10 +38,23 @@ namespace event {
  */
 class Event {
  public:
+    /**
+     * @enum The priority of the event, the ready events with higher priority are dispatched first
+     *
+     * The priority orders the events within one bus. The loop dispatches
+     * all the expired timers before it polls the handles, whatever their priority.
+    */
+    enum Priority {
+        PRI_HIGH,       ///< high
+        PRI_DEFAULT,    ///< default
+        PRI_LOW,        ///< low
+        PRI_NUM,        ///< the number of priorities
+    };
+
     /**
      * @brief Default constructor
     */
-    Event(): pending(false) {}
+    Event(): pending(false), priority(PRI_DEFAULT) {}
 
 
     /**
@@ -67,12 +80,33 @@ class Event {
     */
     void setPending(bool pending) {
         mutex.lock();
-        pending = pending;
+        this->pending = pending;
         mutex.unlock();
     }
 
+
+    /**
+     * @brief Get the priority of the event
+     *
+     * @return the priority
+    */
+    Priority getPriority() const {
+        return priority;
+    }
+
+
+    /**
+     * @brief Set the priority of the event, it takes effect the next time the event is ready
+     *
+     * @param priority is the priority of the event
+    */
+    void setPriority(Priority priority) {
+        this->priority = priority;
+    }
+
  private:
     bool pending;
+    Priority priority;
     platform::Lock mutex;
 };
 
@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <sys/inotify.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <event/event.hpp>
+#include <event/bus.hpp>
+#include <event/handle_event.hpp>
+#include <event/timer_event.hpp>
+
+/**
+ * @file file_watch_event.hpp
+ * @brief File watch event interfaces
+*/
+
+#define FILE_WATCH_MASK_DEFAULT (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | \
+    IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVED_FROM | IN_MOVED_TO | \
+    IN_MOVE_SELF)
+
+namespace event {
+
+/**
+ * @brief Triggered when a file or directory changes
+ *
+ * The changes received within the window are coalesced into one callback.
+ * When the kernel drops the watch with IN_IGNORED, e.g. the path was deleted
+ * or replaced by a rename, the changes are delivered at once and the event is
+ * no longer pending. Add it again to watch the new file at the path.
+*/
+class FileWatchEvent: public Event {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param path is the path of the file or directory
+     * @param mask is the inotify events to watch
+     * @param windowMs is the coalescing window in milliseconds, 0 to call back once per read batch
+    */
+    explicit FileWatchEvent(const char *path,
+        u32 mask = FILE_WATCH_MASK_DEFAULT, u32 windowMs = 0):
+        path(path), mask(mask), windowMs(windowMs), events(0), count(0) {}
+
+
+    /**
+     * @brief Empty virtual destructor
+    */
+    virtual ~FileWatchEvent() {}
+
+
+    /**
+     * @brief Get the path
+     *
+     * @return the path of the file or directory
+    */
+    const std::string &getPath() const {
+        return path;
+    }
+
+
+    /**
+     * @brief Get the inotify events to watch
+     *
+     * @return the mask of the events
+    */
+    u32 getMask() const {
+        return mask;
+    }
+
+
+    /**
+     * @brief Get the coalescing window
+     *
+     * @return the window in milliseconds
+    */
+    u32 getWindow() const {
+        return windowMs;
+    }
+
+
+    /**
+     * @brief Set the coalescing window, it takes effect on the next change
+     *
+     * @param ms is the window in milliseconds
+    */
+    void setWindow(u32 ms) {
+        windowMs = ms;
+    }
+
+
+    /**
+     * @brief Get the inotify events received since the last callback
+     *
+     * @return the mask of the events, IN_Q_OVERFLOW if events were lost
+    */
+    u32 getEvents() const {
+        return events;
+    }
+
+
+    /**
+     * @brief Get the number of the changes coalesced
+     *
+     * @return the number of inotify events
+    */
+    u32 getCount() const {
+        return count;
+    }
+
+
+    /**
+     * @brief Get the names of the entries changed in a watched directory
+     *
+     * @return the names, each name once
+    */
+    const std::vector<std::string> &getNames() const {
+        return names;
+    }
+
+ private:
+    friend class FileWatchBus;
+
+    std::string path;
+    u32 mask;
+    u32 windowMs;
+    u32 events;
+    u32 count;
+    std::vector<std::string> names;
+};
+
+typedef common::ObjectException<FileWatchEvent> FileWatchEventException;
+
+/**
+ * @brief Bus of the file watch events, the changes are read from an inotify instance in the handle bus
+*/
+class FileWatchBus: public Bus<FileWatchEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param handleBus is the handle bus to poll the inotify instance
+     * @param timerBus is the timer bus of the coalescing windows
+    */
+    FileWatchBus(HandleBus *handleBus, TimerBus *timerBus);
+
+
+    /**
+     * @brief Remove the watches and close the inotify instance
+    */
+    ~FileWatchBus() override;
+
+
+    /**
+     * @brief Override to add a file watch event to the file watch bus
+    */
+    void addEvent(FileWatchEvent *e, const Callback<FileWatchEvent> *cb) override;
+
+
+    /**
+     * @brief Override to delete a file watch event from the file watch bus
+    */
+    void delEvent(FileWatchEvent *e) override;
+
+ private:
+    class WatchNode;
+    class Reader;
+    class Flusher;
+
+    void onReadable();
+    void onChange(WatchNode *node, u32 events, const char *name);
+    void onIgnored(int wd);
+    void deliver(WatchNode *node);
+
+    HandleBus *handleBus;
+    TimerBus *timerBus;
+    Reader *reader;
+    Flusher *flusher;
+    platform::Handle *handle;
+    HandleEvent *handleEvent;
+    std::unordered_multimap<int, WatchNode *> watches;
+    std::vector<WatchNode *> ready;
+    std::vector<char> buf;
+};
+
+}  // namespace event
@@ -21,6 +21,8 @@
 */
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include <event/event.hpp>
 #include <event/bus.hpp>
 #include <platform/poll.hpp>
@@ -30,6 +32,13 @@
  * @brief Handle event interfaces
 */
 
+/// Bits of the file descriptor in the tokens of the poll callbacks
+#if UINTPTR_MAX > 0xffffffffU
+#define HANDLE_FD_BITS 24
+#else
+#define HANDLE_FD_BITS 16
+#endif
+
 namespace event {
 
 class HandleEvent: public Event {
@@ -51,7 +60,7 @@ class HandleEvent: public Event {
     */
     explicit HandleEvent(platform::Handle *handle,
         Operation op):
-        handle(handle), op(op) {}
+        handle(handle), op(op), budget(1), count(0), more(false) {}
 
 
     /**
@@ -119,14 +128,58 @@ class HandleEvent: public Event {
         this->cb = cb;
     }
 
+
+    /**
+     * @brief Get the dispatch budget of the event
+     *
+     * @return the maximum number of times the callback is called per loop iteration
+    */
+    u32 getBudget() const {
+        return budget;
+    }
+
+
+    /**
+     * @brief Set the dispatch budget of the event
+     *
+     * @param budget is the maximum number of times the callback is called per loop iteration, at least 1
+    */
+    void setBudget(u32 budget) {
+        this->budget = budget ? budget : 1;
+    }
+
+
+    /**
+     * @brief Ask the bus to call the callback again in the current iteration
+     *
+     * The callback is called again after the other ready events with the same priority,
+     * the request is ignored once the budget of the event is exhausted.
+    */
+    void again() {
+        more = true;
+    }
+
  private:
+    friend class HandleBus;
+
     const Callback<HandleEvent> *cb;
     platform::Handle *handle;
     Operation op;
+    u32 budget;
+    u32 count;
+    bool more;
 };
 
 typedef common::ObjectException<HandleEvent> HandleEventException;
 
+/**
+ * @brief Bus of the handle events
+ *
+ * The events are kept in a table indexed by the file descriptor, each entry
+ * has a generation which is increased when the event is deleted. The poll
+ * callbacks only carry the descriptor, the operation and the generation,
+ * so readiness reported for a deleted event or a reused descriptor is dropped.
+*/
 class HandleBus: public Bus<HandleEvent> {
  public:
     /**
@@ -150,9 +203,35 @@ class HandleBus: public Bus<HandleEvent> {
     */
     int dispatch(int timeout) override;
 
+
+    /**
+     * @brief Get the file descriptor of the poller, it is readable when a handle is ready
+     *
+     * @return the file descriptor
+    */
+    int getFd() {
+        return poll.getFd();
+    }
+
  private:
+    static const int OP_NUM = HandleEvent::OP_EXCEPTION + 1;
+
+    struct Slot {
+        HandleEvent *events[OP_NUM];
+        u32 gens[OP_NUM];
+    };
+
+    typedef uintptr_t Token;
+
+    static Token makeToken(int fd, HandleEvent::Operation op, u32 gen);
+    HandleEvent *lookup(Token token) const;
+    void onReady(Token token);
+
     platform::Poll::Event getEvent(HandleEvent::Operation op);
     platform::Poll poll;
+    std::vector<Slot> table;
+    std::vector<Token> ready[Event::PRI_NUM];
+    static thread_local HandleBus *polling;
 };
 
 }  // namespace event
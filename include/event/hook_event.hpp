@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <event/event.hpp>
+#include <event/bus.hpp>
+
+/**
+ * @file hook_event.hpp
+ * @brief Loop hook interfaces
+*/
+
+namespace event {
+
+/**
+ * @brief Called before the loop blocks in polling
+*/
+class PrepareEvent: public Event {};
+
+/**
+ * @brief Called after the ready handle events are dispatched
+*/
+class CheckEvent: public Event {};
+
+/**
+ * @brief Called at the end of each iteration, the loop does not block in polling while any is added
+*/
+class IdleEvent: public Event {};
+
+/**
+ * @brief Bus of the hooks which are called once per loop iteration
+ *
+ * The hooks stay added until @c delEvent() is called,
+ * they are called by priority, then in the order they were added.
+*/
+template <class T>
+class HookBus: public Bus<T> {
+ public:
+    /**
+     * @brief Default constructor
+    */
+    HookBus(): dispatching(false) {}
+
+
+    /**
+     * @brief Override to add a hook to the bus
+    */
+    void addEvent(T *e, const Callback<T> *cb) override {
+        if (e->isPending()) {
+            throw common::ObjectException<T>(e,
+                common::ERR_BUSY, "the event was added");
+        }
+        e->setPending(true);
+        if (dispatching) {
+            added.push_back(Hook(e, cb));
+            return;
+        }
+        insert(Hook(e, cb));
+    }
+
+
+    /**
+     * @brief Override to delete a hook from the bus
+    */
+    void delEvent(T *e) override {
+        if (!e->isPending()) {
+            throw common::ObjectException<T>(e,
+                common::ERR_BUSY, "the event was not added");
+        }
+        e->setPending(false);
+        if (dispatching) {
+            // Removed after the dispatch
+            invalidate(&hooks, e);
+            invalidate(&added, e);
+            return;
+        }
+        for (auto it = hooks.begin(); it != hooks.end(); it++) {
+            if (it->e == e) {
+                hooks.erase(it);
+                return;
+            }
+        }
+    }
+
+
+    /**
+     * @brief Override to call all the hooks
+     *
+     * @return -1, the hooks do not need to wait
+    */
+    int dispatch() override {
+        dispatching = true;
+        for (size_t i = 0; i < hooks.size(); i++) {
+            if (hooks[i].e) {
+                hooks[i].cb->onEvent(hooks[i].e);
+            }
+        }
+        dispatching = false;
+
+        size_t n = 0;
+        for (size_t i = 0; i < hooks.size(); i++) {
+            if (hooks[i].e) {
+                hooks[n++] = hooks[i];
+            }
+        }
+        hooks.erase(hooks.begin() + n, hooks.end());
+        for (const Hook &hook : added) {
+            if (hook.e) {
+                insert(hook);
+            }
+        }
+        added.clear();
+        return -1;
+    }
+
+
+    /**
+     * @brief Whether no hook is added
+     *
+     * @return true if the bus is empty
+    */
+    bool isEmpty() const {
+        return hooks.empty() && added.empty();
+    }
+
+ private:
+    struct Hook {
+        Hook(T *e, const Callback<T> *cb): e(e), cb(cb) {}
+        T *e;
+        const Callback<T> *cb;
+    };
+
+    void insert(const Hook &hook) {
+        auto it = hooks.end();
+        while (it != hooks.begin() &&
+            (it - 1)->e->getPriority() > hook.e->getPriority()) {
+            it--;
+        }
+        hooks.insert(it, hook);
+    }
+
+    static void invalidate(std::vector<Hook> *list, T *e) {
+        for (Hook &hook : *list) {
+            if (hook.e == e) {
+                hook.e = nullptr;
+            }
+        }
+    }
+
+    bool dispatching;
+    std::vector<Hook> hooks;
+    std::vector<Hook> added;
+};
+
+/**
+ * @brief Bus of the prepare hooks
+*/
+class PrepareBus: public HookBus<PrepareEvent> {};
+
+/**
+ * @brief Bus of the check hooks
+*/
+class CheckBus: public HookBus<CheckEvent> {};
+
+/**
+ * @brief Bus of the idle hooks
+*/
+class IdleBus: public HookBus<IdleEvent> {};
+
+}  // namespace event
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <vector>
+#include <event/event.hpp>
+#include <event/bus.hpp>
+#include <event/handle_event.hpp>
+#include <event/timer_event.hpp>
+
+/**
+ * @file listener_event.hpp
+ * @brief Listener event interfaces
+*/
+
+#define LISTENER_BUDGET_DEFAULT 64U
+
+/// The delay to retry accepting after running out of descriptors or memory
+#define LISTENER_RETRY_MS 100U
+
+namespace event {
+
+/**
+ * @brief Triggered with the connections accepted from a listening socket in one iteration
+*/
+class ListenerEvent: public Event {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param handle A point to the listening socket
+    */
+    explicit ListenerEvent(platform::Handle *handle):
+        handle(handle), budget(LISTENER_BUDGET_DEFAULT),
+        maxConns(0), conns(0) {}
+
+
+    /**
+     * @brief Empty virtual destructor
+    */
+    virtual ~ListenerEvent() {}
+
+
+    /**
+     * @brief Get the listening socket
+     *
+     * @return the point of the handle
+    */
+    platform::Handle *getHandle() const {
+        return handle;
+    }
+
+
+    /**
+     * @brief Set the maximum number of connections accepted per loop iteration
+     *
+     * @param budget is the number of connections, at least 1
+    */
+    void setBudget(u32 budget) {
+        this->budget = budget ? budget : 1;
+    }
+
+
+    /**
+     * @brief Set the maximum number of open connections, accepting is paused when reached
+     *
+     * @param max is the number of connections, 0 if unlimited
+    */
+    void setMaxConnections(u32 max) {
+        maxConns = max;
+    }
+
+
+    /**
+     * @brief Get the number of open connections
+     *
+     * @return the connections accepted and not released
+    */
+    u32 getConnections() const {
+        return conns;
+    }
+
+
+    /**
+     * @brief Get the connections accepted in this iteration
+     *
+     * The descriptors are non-blocking and close-on-exec, they are owned by the callback.
+     *
+     * @return the file descriptors of the connections
+    */
+    const std::vector<int> &getAccepted() const {
+        return accepted;
+    }
+
+ private:
+    friend class ListenerBus;
+
+    platform::Handle *handle;
+    u32 budget;
+    u32 maxConns;
+    u32 conns;
+    std::vector<int> accepted;
+};
+
+typedef common::ObjectException<ListenerEvent> ListenerEventException;
+
+/**
+ * @brief Bus of the listener events, the listening sockets are polled in the handle bus
+ *
+ * When @c accept4() runs out of descriptors or memory, the listening socket
+ * is paused until connections are released or @c LISTENER_RETRY_MS elapsed.
+*/
+class ListenerBus: public Bus<ListenerEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param handleBus is the handle bus to poll the listening sockets
+     * @param timerBus is the timer bus to retry accepting
+    */
+    ListenerBus(HandleBus *handleBus, TimerBus *timerBus);
+
+
+    /**
+     * @brief Delete the listening sockets from the handle bus
+    */
+    ~ListenerBus() override;
+
+
+    /**
+     * @brief Override to add a listener event to the listener bus
+    */
+    void addEvent(ListenerEvent *e, const Callback<ListenerEvent> *cb) override;
+
+
+    /**
+     * @brief Override to delete a listener event from the listener bus
+    */
+    void delEvent(ListenerEvent *e) override;
+
+
+    /**
+     * @brief Release connections accepted by the listener, accepting is resumed if it was paused
+     *
+     * @param e is a pointer to the event
+     * @param n is the number of connections closed
+    */
+    void release(ListenerEvent *e, u32 n = 1);
+
+ private:
+    class ListenerNode;
+    class Acceptor;
+    class Retrier;
+
+    ListenerNode *find(ListenerEvent *e);
+    void remove(ListenerNode *node);
+    void pause(ListenerNode *node);
+    void resume(ListenerNode *node);
+    void onReadable(ListenerNode *node);
+
+    HandleBus *handleBus;
+    TimerBus *timerBus;
+    Acceptor *acceptor;
+    Retrier *retrier;
+    ListenerNode *listenerHead;
+};
+
+}  // namespace event
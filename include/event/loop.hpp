@@ -23,6 +23,8 @@
 
 #include <event/handle_event.hpp>
 #include <event/timer_event.hpp>
+#include <event/hook_event.hpp>
+#include <event/arena.hpp>
 
 /**
  * @file loop.hpp
@@ -33,8 +35,14 @@ namespace event {
 
 /**
  * @brief Event loop class, inherited from the bus base class
+ *
+ * Each iteration dispatches the expired timers, calls the prepare hooks,
+ * polls and dispatches the ready handles, then calls the check and idle hooks.
+ * With a virtual clock the loop polls without blocking and advances
+ * the clock to the next timer.
 */
-class Loop: public HandleBus, public TimerBus {
+class Loop: public HandleBus, public TimerBus,
+    public PrepareBus, public CheckBus, public IdleBus {
  public:
     /**
      * @brief Default constructor
@@ -54,13 +62,51 @@ class Loop: public HandleBus, public TimerBus {
     void start();
 
 
+    /**
+     * @brief Run one iteration of the loop
+     *
+     * @param timeout Specifies the maximum wait time in milliseconds(-1 == until the next timer, or infinite without timers)
+    */
+    void runOnce(int timeout = -1);
+
+
+    /**
+     * @brief Run one iteration of the loop without blocking
+    */
+    void runNoWait() {
+        runOnce(0);
+    }
+
+
+    /**
+     * @brief Get the time until the loop has work to do without a handle being ready
+     *
+     * To nest the loop in another event loop, wait for @c getFd() to be readable
+     * or for this timeout to expire, then call @c runNoWait().
+     *
+     * @return the time in milliseconds, -1 if infinite
+    */
+    int getTimeout();
+
+
     /**
      * @brief Exit the loop
     */
     void exit();
 
+
+    /**
+     * @brief Get the arena to allocate the events and callbacks of the loop
+     *
+     * @return a pointer to the arena, only used in the thread running the loop
+    */
+    Arena *getArena() {
+        return &arena;
+    }
+
  private:
     bool loop;
+    Arena arena;
 };
 
 }  // namespace event
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <signal.h>
+#include <vector>
+#include <event/event.hpp>
+#include <event/bus.hpp>
+#include <event/handle_event.hpp>
+
+/**
+ * @file signal_event.hpp
+ * @brief Signal event interfaces
+*/
+
+namespace event {
+
+/**
+ * @brief Triggered each time the signal is received
+*/
+class SignalEvent: public Event {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param signo is the signal number
+    */
+    explicit SignalEvent(int signo): signo(signo), count(0), received(0) {}
+
+
+    /**
+     * @brief Empty virtual destructor
+    */
+    virtual ~SignalEvent() {}
+
+
+    /**
+     * @brief Get the signal number
+     *
+     * @return the signal number
+    */
+    int getSignal() const {
+        return signo;
+    }
+
+
+    /**
+     * @brief Get the number of signals received since the last callback
+     *
+     * @return the number of signals
+    */
+    u32 getCount() const {
+        return count;
+    }
+
+ private:
+    friend class SignalBus;
+
+    int signo;
+    u32 count;
+    u32 received;
+};
+
+typedef common::ObjectException<SignalEvent> SignalEventException;
+
+/**
+ * @brief Bus of the signal events, the signals are received from a signalfd in the handle bus
+ *
+ * The signals are blocked in the thread adding the events,
+ * so the events should be added before other threads are created.
+ * When the last event of a signal is deleted, the pending signals are
+ * discarded and the signal is unblocked, unless it was blocked before.
+*/
+class SignalBus: public Bus<SignalEvent> {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param bus is the handle bus to poll the signalfd
+    */
+    explicit SignalBus(HandleBus *bus);
+
+
+    /**
+     * @brief Delete the signalfd and unblock the signals
+    */
+    ~SignalBus() override;
+
+
+    /**
+     * @brief Override to add a signal event to the signal bus
+    */
+    void addEvent(SignalEvent *e, const Callback<SignalEvent> *cb) override;
+
+
+    /**
+     * @brief Override to delete a signal event from the signal bus
+    */
+    void delEvent(SignalEvent *e) override;
+
+ private:
+    class Reader;
+    struct SignalState {
+        SignalState(SignalEvent *e, const Callback<SignalEvent> *cb):
+            e(e), cb(cb) {}
+        SignalEvent *e;
+        const Callback<SignalEvent> *cb;
+    };
+
+    void update();
+    void unblock(const sigset_t *set);
+    void onReadable();
+
+    HandleBus *bus;
+    Reader *reader;
+    platform::Handle *handle;
+    HandleEvent *handleEvent;
+    sigset_t mask;
+    sigset_t blocked;
+    std::vector<SignalState> events;
+};
+
+}  // namespace event
@@ -23,6 +23,7 @@
 
 #include <event/event.hpp>
 #include <event/bus.hpp>
+#include <event/clock.hpp>
 
 /**
  * @file timer_event.hpp
@@ -41,7 +42,7 @@ class TimerEvent: public Event {
     /**
      * @brief Default constructor
     */
-    TimerEvent(): timeMs(0) {}
+    TimerEvent(): timeMs(0), delayMs(0), cb(nullptr), next(nullptr) {}
 
 
     /**
@@ -51,38 +52,56 @@ class TimerEvent: public Event {
 
 
     /**
-     * @brief Set the timeout of the timer event
+     * @brief Set the timeout of the timer event, it starts when the event is added
      *
      * @param ms is the time as the number of milliseconds
     */
     void setTimeout(u32 ms);
 
 
+    /**
+     * @brief Get the timeout of the timer event
+     *
+     * @return the time as the number of milliseconds
+    */
+    u32 getTimeout() const {
+        return delayMs;
+    }
+
+
     /**
      * @brief Get the timestamp when the event was triggered
      * 
-     * @return the time as the number of milliseconds since 1970-01-01 00:00 (UTC).
+     * @return the time as the number of milliseconds of the clock of the bus, set when the event is added
     */
     u64 getTimeMs() const;
 
  private:
+    friend class TimerBus;
+
     u64 timeMs;
+    u32 delayMs;
+    const Callback<TimerEvent> *cb;
+    TimerEvent *next;
 };
 
 typedef common::ObjectException<TimerEvent> TimerEventException;
 
+class TraceRecorder;
+
 class TimerBus: public Bus<TimerEvent> {
  public:
     /**
      * @brief Default constructor
     */
-    TimerBus(): timerHead(nullptr) {}
+    TimerBus(): clock(&SystemClock::Instance()), recorder(nullptr),
+        timerHead(nullptr), readyHead() {}
 
 
     /**
      * @brief Empty virtual destructor
     */
-    ~TimerBus() override;
+    ~TimerBus() override {}
 
 
     /**
@@ -98,16 +117,65 @@ class TimerBus: public Bus<TimerEvent> {
 
 
     /**
-     * @brief Trigger timer event and return delay until next timer fires.
+     * @brief Trigger the expired timer events by priority and return delay until next timer fires.
      * 
      * @return -1 if no timer events.
     */
     int dispatch() override;
 
+
+    /**
+     * @brief Get the delay until the next timer fires, without dispatching
+     *
+     * @return -1 if no timer events, 0 if a timer has expired.
+    */
+    int getTimeout();
+
+
+    /**
+     * @brief Get the deadline of the next timer
+     *
+     * @param ms is a pointer to the time in milliseconds of the clock of the bus
+     *
+     * @return false if no timer events
+    */
+    bool getNextTimeMs(u64 *ms);
+
+
+    /**
+     * @brief Get the clock of the timer bus
+     *
+     * @return a pointer to the clock
+    */
+    Clock *getClock() const {
+        return clock;
+    }
+
+
+    /**
+     * @brief Set the clock of the timer bus, no timer event can be added
+     *
+     * @param clock is a pointer to the clock
+    */
+    void setClock(Clock *clock);
+
+
+    /**
+     * @brief Record the timer events added, deleted and fired
+     *
+     * @param recorder is a pointer to the recorder, nullptr to stop recording
+    */
+    void setRecorder(TraceRecorder *recorder) {
+        this->recorder = recorder;
+    }
+
  private:
-    class TimerNode;
     int timerAdvance();
-    TimerNode *timerHead;
+    static bool unlink(TimerEvent **list, TimerEvent *e);
+    Clock *clock;
+    TraceRecorder *recorder;
+    TimerEvent *timerHead;
+    TimerEvent *readyHead[Event::PRI_NUM];
     platform::Lock mutex;
 };
 
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include <event/timer_event.hpp>
+
+/**
+ * @file trace.hpp
+ * @brief Timer trace interfaces
+ *
+ * A trace starts with the magic "EVTR" and a version byte, followed by
+ * records of a type byte, the varint milliseconds since the previous
+ * record and the varint ID of the timer. An add record also has the
+ * varint timeout and the priority byte.
+*/
+
+namespace event {
+
+/**
+ * @brief Record the timer events of a timer bus to a binary file
+*/
+class TraceRecorder {
+ public:
+    /**
+     * @brief Default constructor
+     *
+     * @param path is the path of the trace file
+    */
+    explicit TraceRecorder(const char *path);
+
+
+    /**
+     * @brief Flush and close the trace file
+    */
+    ~TraceRecorder();
+
+
+    /**
+     * @brief Called when the event is added
+     *
+     * @param e is a pointer to the event
+     * @param ms is the time of the clock of the bus
+    */
+    void onAdd(const TimerEvent *e, u64 ms);
+
+
+    /**
+     * @brief Called when the event is deleted
+     *
+     * @param e is a pointer to the event
+     * @param ms is the time of the clock of the bus
+    */
+    void onDel(const TimerEvent *e, u64 ms);
+
+
+    /**
+     * @brief Called when the event is fired
+     *
+     * @param e is a pointer to the event
+     * @param ms is the time of the clock of the bus
+    */
+    void onFire(const TimerEvent *e, u64 ms);
+
+
+    /**
+     * @brief Write the buffered records to the file
+    */
+    void flush();
+
+ private:
+    u32 getId(const TimerEvent *e);
+    void putId(const TimerEvent *e);
+    void putRecord(u8 type, const TimerEvent *e, u64 ms);
+    void putVarint(u64 val);
+
+    FILE *fp;
+    std::vector<u8> buf;
+    std::unordered_map<const TimerEvent *, u32> ids;
+    std::vector<u32> freeIds;
+    u32 nextId;
+    u64 lastMs;
+    bool started;
+};
+
+/**
+ * @brief Replay a trace on a timer bus with a virtual clock, as fast as possible
+*/
+class TraceReplayer {
+ public:
+    /**
+     * @brief Default constructor, load the trace file
+     *
+     * @param path is the path of the trace file
+    */
+    explicit TraceReplayer(const char *path);
+
+
+    /**
+     * @brief Replay the trace
+     *
+     * @param bus is the timer bus without timer events
+     * @param clock is the clock set to the bus
+     *
+     * @return the number of the timer events fired until the last record
+    */
+    u64 replay(TimerBus *bus, VirtualClock *clock);
+
+ private:
+    bool getVarint(size_t *pos, u64 *val) const;
+    void advance(TimerBus *bus, VirtualClock *clock, u64 ms);
+
+    std::vector<u8> data;
+};
+
+typedef common::ObjectException<TraceRecorder> TraceRecorderException;
+typedef common::ObjectException<TraceReplayer> TraceReplayerException;
+
+}  // namespace event
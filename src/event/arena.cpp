@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <cstdint>
+#include <event/arena.hpp>
+
+/// The size of the smallest class, including the block header
+#define ARENA_CLASS_MIN 64U
+
+/// The class of the blocks allocated out of the slabs
+#define ARENA_CLASS_LARGE ARENA_CLASS_NUM
+
+namespace event {
+
+void Arena::Group::release() {
+    Block *b;
+
+    while (head.prev != &head) {
+        b = head.prev;
+        unlink(b);
+        b->dtor(data(b));
+        arena->free(b);
+    }
+}
+
+Arena::Arena(): freeList() {}
+
+Arena::~Arena() {
+    for (void *slab : slabs) {
+        ::operator delete(slab);
+    }
+}
+
+Arena::Block *Arena::alloc(size_t size, size_t align) {
+    size_t blockSize = ARENA_CLASS_MIN;
+    u32 cls = 0;
+    uintptr_t addr;
+    Block *b;
+    char *base, *slab;
+
+    // The object is aligned right after the header
+    size += (HEADER_SIZE + align - 1) / align * align;
+    while (cls < ARENA_CLASS_NUM && blockSize < size) {
+        blockSize <<= 1;
+        cls++;
+    }
+    if (cls == ARENA_CLASS_LARGE) {
+        // operator new only guarantees the alignment of max_align_t
+        if (align > alignof(std::max_align_t)) {
+            size += align - alignof(std::max_align_t);
+        }
+        base = static_cast<char *>(::operator new(size));
+    } else {
+        if (!freeList[cls]) {
+            // Carve a new aligned slab into blocks of the class
+            slab = static_cast<char *>(::operator new(ARENA_SLAB_SIZE +
+                ARENA_ALIGN_MAX));
+            slabs.push_back(slab);
+            addr = reinterpret_cast<uintptr_t>(slab);
+            slab += (addr + ARENA_ALIGN_MAX - 1) / ARENA_ALIGN_MAX *
+                ARENA_ALIGN_MAX - addr;
+            for (size_t off = 0; off + blockSize <= ARENA_SLAB_SIZE;
+                off += blockSize) {
+                b = reinterpret_cast<Block *>(slab + off);
+                b->next = freeList[cls];
+                freeList[cls] = b;
+            }
+        }
+        base = reinterpret_cast<char *>(freeList[cls]);
+        freeList[cls] = freeList[cls]->next;
+    }
+    addr = reinterpret_cast<uintptr_t>(base) + HEADER_SIZE;
+    addr = (addr + align - 1) / align * align;
+    b = block(reinterpret_cast<void *>(addr));
+    b->prev = b->next = b;
+    b->dtor = nullptr;
+    b->cls = cls;
+    b->offset = reinterpret_cast<char *>(b) - base;
+    return b;
+}
+
+void Arena::free(Block *b) {
+    char *base = reinterpret_cast<char *>(b) - b->offset;
+    u32 cls = b->cls;
+
+    if (cls == ARENA_CLASS_LARGE) {
+        ::operator delete(base);
+        return;
+    }
+    b = reinterpret_cast<Block *>(base);
+    b->next = freeList[cls];
+    freeList[cls] = b;
+}
+
+}  // namespace event
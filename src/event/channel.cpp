@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <event/channel.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace event {
+
+class ChannelBus::ChannelNode: public HandleEvent {
+ public:
+    ChannelNode(ChannelEvent *e, const Callback<ChannelEvent> *cb,
+        ChannelNode *next):
+        HandleEvent(e->handle, OP_READ), e(e), cb(cb), next(next) {}
+
+    ChannelEvent *e;
+    const Callback<ChannelEvent> *cb;
+    ChannelNode *next;
+};
+
+class ChannelBus::Receiver: public Callback<HandleEvent> {
+ public:
+    explicit Receiver(ChannelBus *bus): bus(bus) {}
+
+    void onEvent(HandleEvent *e) const override {
+        bus->onReadable(static_cast<ChannelNode *>(e));
+    }
+
+ private:
+    ChannelBus *bus;
+};
+
+ChannelEvent::ChannelEvent(): waiting(true), handle(nullptr) {
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        throw ChannelEventException(this,
+            common::ERR_PERM, "failed to create eventfd");
+    }
+    handle = new platform::Handle(fd);
+}
+
+ChannelEvent::~ChannelEvent() {
+    close(handle->getFd());
+    delete handle;
+}
+
+void ChannelEvent::wakeup() {
+    u64 val = 1;
+    ssize_t ret = write(handle->getFd(), &val, sizeof(val));
+    (void)ret;
+}
+
+void ChannelEvent::clear() {
+    u64 val;
+    ssize_t ret = read(handle->getFd(), &val, sizeof(val));
+    (void)ret;
+}
+
+ChannelBus::ChannelBus(HandleBus *bus): bus(bus),
+    receiver(new Receiver(this)), channelHead(nullptr) {}
+
+ChannelBus::~ChannelBus() {
+    while (channelHead) {
+        channelHead->e->setPending(false);
+        remove(channelHead);
+    }
+    delete receiver;
+}
+
+void ChannelBus::addEvent(ChannelEvent *e, const Callback<ChannelEvent> *cb) {
+    if (e->isPending()) {
+        throw ChannelEventException(e,
+            common::ERR_BUSY, "the event was added");
+    }
+    e->setPending(true);
+    channelHead = new ChannelNode(e, cb, channelHead);
+    bus->addEvent(channelHead, receiver);
+}
+
+void ChannelBus::delEvent(ChannelEvent *e) {
+    ChannelNode *node;
+
+    if (!e->isPending()) {
+        throw ChannelEventException(e,
+            common::ERR_BUSY, "the event was not added");
+    }
+    e->setPending(false);
+    node = find(e);
+    if (node) {
+        remove(node);
+    }
+}
+
+ChannelBus::ChannelNode *ChannelBus::find(ChannelEvent *e) {
+    ChannelNode *cur;
+
+    for (cur = channelHead; cur; cur = cur->next) {
+        if (cur->e == e) {
+            return cur;
+        }
+    }
+    return nullptr;
+}
+
+void ChannelBus::remove(ChannelNode *node) {
+    ChannelNode **t = &channelHead;
+
+    while (*t != node) {
+        t = &(*t)->next;
+    }
+    *t = node->next;
+    bus->delEvent(node);
+    delete node;
+}
+
+void ChannelBus::onReadable(ChannelNode *node) {
+    ChannelEvent *e = node->e;
+
+    e->clear();
+    node->cb->onEvent(e);
+
+    // Deleted in the callback
+    if (find(e) != node) {
+        return;
+    }
+
+    // The callback may stop before a failing recv(), re-arm the channel
+    // and notify if a message was sent before the sender could see it
+    if (!e->waiting.load()) {
+        e->wait();
+        if (!e->isEmpty()) {
+            e->notify();
+        }
+    }
+}
+
+}  // namespace event
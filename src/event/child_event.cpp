@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <event/child_event.hpp>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+namespace event {
+
+class ChildBus::ChildNode: public HandleEvent {
+ public:
+    ChildNode(ChildEvent *e, const Callback<ChildEvent> *cb, int fd,
+        ChildNode *next):
+        HandleEvent(new platform::Handle(fd), OP_READ),
+        e(e), cb(cb), next(next) {}
+
+    ~ChildNode() {
+        close(getHandle()->getFd());
+        delete getHandle();
+    }
+
+    ChildEvent *e;
+    const Callback<ChildEvent> *cb;
+    ChildNode *next;
+};
+
+class ChildBus::Reaper: public Callback<HandleEvent> {
+ public:
+    explicit Reaper(ChildBus *bus): bus(bus) {}
+
+    void onEvent(HandleEvent *e) const override {
+        bus->onExited(static_cast<ChildNode *>(e));
+    }
+
+ private:
+    ChildBus *bus;
+};
+
+ChildBus::ChildBus(HandleBus *bus): bus(bus), reaper(new Reaper(this)),
+    childHead(nullptr) {}
+
+ChildBus::~ChildBus() {
+    while (childHead) {
+        childHead->e->setPending(false);
+        remove(childHead);
+    }
+    delete reaper;
+}
+
+void ChildBus::addEvent(ChildEvent *e, const Callback<ChildEvent> *cb) {
+    int fd;
+
+    if (e->isPending()) {
+        throw ChildEventException(e,
+            common::ERR_BUSY, "the event was added");
+    }
+    fd = static_cast<int>(syscall(SYS_pidfd_open, e->getPid(), 0));
+    if (fd < 0) {
+        throw ChildEventException(e,
+            common::ERR_PERM, "failed to open pidfd");
+    }
+    e->setPending(true);
+    childHead = new ChildNode(e, cb, fd, childHead);
+    bus->addEvent(childHead, reaper);
+}
+
+void ChildBus::delEvent(ChildEvent *e) {
+    ChildNode *cur;
+
+    if (!e->isPending()) {
+        throw ChildEventException(e,
+            common::ERR_BUSY, "the event was not added");
+    }
+    e->setPending(false);
+    for (cur = childHead; cur; cur = cur->next) {
+        if (cur->e == e) {
+            remove(cur);
+            return;
+        }
+    }
+}
+
+void ChildBus::remove(ChildNode *node) {
+    ChildNode **t = &childHead;
+
+    while (*t != node) {
+        t = &(*t)->next;
+    }
+    *t = node->next;
+    bus->delEvent(node);
+    delete node;
+}
+
+void ChildBus::onExited(ChildNode *node) {
+    ChildEvent *e = node->e;
+    const Callback<ChildEvent> *cb = node->cb;
+    siginfo_t info;
+
+    info.si_pid = 0;
+    if (waitid(static_cast<idtype_t>(P_PIDFD), node->getHandle()->getFd(),
+        &info, WEXITED | WNOHANG)) {
+        // Reaped elsewhere, the status is lost
+        info.si_code = 0;
+        info.si_status = 0;
+    } else if (!info.si_pid) {
+        return;
+    }
+    e->code = info.si_code;
+    e->status = info.si_status;
+    e->setPending(false);
+    remove(node);
+    cb->onEvent(e);
+}
+
+}  // namespace event
@@ -0,0 +1,256 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <event/file_watch_event.hpp>
+#include <unistd.h>
+#include <algorithm>
+
+/// The size of the buffer to read the inotify events
+#define FILE_WATCH_BUF_SIZE 65536
+
+namespace event {
+
+class FileWatchBus::WatchNode: public TimerEvent {
+ public:
+    WatchNode(FileWatchEvent *e, const Callback<FileWatchEvent> *cb, int wd):
+        e(e), cb(cb), wd(wd), events(0), count(0) {}
+
+    FileWatchEvent *e;
+    const Callback<FileWatchEvent> *cb;
+    int wd;
+    u32 events;
+    u32 count;
+    std::vector<std::string> names;
+};
+
+class FileWatchBus::Reader: public Callback<HandleEvent> {
+ public:
+    explicit Reader(FileWatchBus *bus): bus(bus) {}
+
+    void onEvent(HandleEvent *) const override {
+        bus->onReadable();
+    }
+
+ private:
+    FileWatchBus *bus;
+};
+
+class FileWatchBus::Flusher: public Callback<TimerEvent> {
+ public:
+    explicit Flusher(FileWatchBus *bus): bus(bus) {}
+
+    void onEvent(TimerEvent *e) const override {
+        bus->deliver(static_cast<WatchNode *>(e));
+    }
+
+ private:
+    FileWatchBus *bus;
+};
+
+FileWatchBus::FileWatchBus(HandleBus *handleBus, TimerBus *timerBus):
+    handleBus(handleBus), timerBus(timerBus), reader(new Reader(this)),
+    flusher(new Flusher(this)), handle(nullptr), handleEvent(nullptr) {}
+
+FileWatchBus::~FileWatchBus() {
+    while (!watches.empty()) {
+        WatchNode *node = watches.begin()->second;
+        node->e->setPending(false);
+        watches.erase(watches.begin());
+        if (node->isPending()) {
+            timerBus->delEvent(node);
+        }
+        delete node;
+    }
+    if (handle) {
+        handleBus->delEvent(handleEvent);
+        delete handleEvent;
+        close(handle->getFd());
+        delete handle;
+    }
+    delete flusher;
+    delete reader;
+}
+
+void FileWatchBus::addEvent(FileWatchEvent *e,
+    const Callback<FileWatchEvent> *cb) {
+    int fd, wd;
+
+    if (e->isPending()) {
+        throw FileWatchEventException(e,
+            common::ERR_BUSY, "the event was added");
+    }
+    if (!handle) {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            throw FileWatchEventException(e,
+                common::ERR_PERM, "failed to create inotify instance");
+        }
+        handle = new platform::Handle(fd);
+        handleEvent = new HandleEvent(handle, HandleEvent::OP_READ);
+        handleBus->addEvent(handleEvent, reader);
+        buf.resize(FILE_WATCH_BUF_SIZE);
+    }
+
+    // The events of the same path share the watch
+    wd = inotify_add_watch(handle->getFd(), e->getPath().c_str(),
+        e->getMask() | IN_MASK_ADD);
+    if (wd < 0) {
+        throw FileWatchEventException(e,
+            common::ERR_PERM, "failed to watch the path");
+    }
+    e->setPending(true);
+    e->events = 0;
+    e->count = 0;
+    e->names.clear();
+    watches.insert(std::make_pair(wd, new WatchNode(e, cb, wd)));
+}
+
+void FileWatchBus::delEvent(FileWatchEvent *e) {
+    WatchNode *node = nullptr;
+
+    if (!e->isPending()) {
+        throw FileWatchEventException(e,
+            common::ERR_BUSY, "the event was not added");
+    }
+    e->setPending(false);
+    for (auto it = watches.begin(); it != watches.end(); it++) {
+        if (it->second->e == e) {
+            node = it->second;
+            watches.erase(it);
+            break;
+        }
+    }
+    if (!node) {
+        return;
+    }
+    if (!watches.count(node->wd)) {
+        inotify_rm_watch(handle->getFd(), node->wd);
+    }
+    if (node->isPending()) {
+        timerBus->delEvent(node);
+    }
+    std::replace(ready.begin(), ready.end(), node,
+        static_cast<WatchNode *>(nullptr));
+    delete node;
+}
+
+void FileWatchBus::onReadable() {
+    char *buf = this->buf.data();
+    const struct inotify_event *ev;
+    ssize_t len;
+    char *p;
+
+    for (;;) {
+        len = read(handle->getFd(), buf, this->buf.size());
+        if (len <= 0) {
+            break;
+        }
+        for (p = buf; p < buf + len; p += sizeof(*ev) + ev->len) {
+            ev = reinterpret_cast<const struct inotify_event *>(p);
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // Events were lost, notify all the watches
+                for (auto &w : watches) {
+                    onChange(w.second, IN_Q_OVERFLOW, nullptr);
+                }
+                continue;
+            }
+            auto range = watches.equal_range(ev->wd);
+            for (auto it = range.first; it != range.second; it++) {
+                onChange(it->second, ev->mask,
+                    ev->len ? ev->name : nullptr);
+            }
+            if (ev->mask & IN_IGNORED) {
+                onIgnored(ev->wd);
+            }
+        }
+    }
+
+    // Deliver the events without window once per read batch,
+    // the callbacks may delete events
+    for (size_t i = 0; i < ready.size(); i++) {
+        WatchNode *node = ready[i];
+        bool dropped;
+        if (!node) {
+            continue;
+        }
+        // The watch was dropped, the event was removed from the bus,
+        // a live node may be freed by delEvent() in the callback
+        dropped = node->wd < 0;
+        deliver(node);
+        if (dropped) {
+            delete node;
+        }
+    }
+    ready.clear();
+}
+
+void FileWatchBus::onChange(WatchNode *node, u32 events, const char *name) {
+    events &= node->e->getMask() | IN_IGNORED | IN_Q_OVERFLOW;
+    if (!events) {
+        return;
+    }
+    if (name && std::find(node->names.begin(), node->names.end(), name) ==
+        node->names.end()) {
+        node->names.push_back(name);
+    }
+    if (!node->count) {
+        // The first change of the window
+        if (node->e->getWindow()) {
+            node->setTimeout(node->e->getWindow());
+            timerBus->addEvent(node, flusher);
+        } else {
+            ready.push_back(node);
+        }
+    }
+    node->events |= events;
+    node->count++;
+}
+
+void FileWatchBus::onIgnored(int wd) {
+    auto range = watches.equal_range(wd);
+
+    // The kernel removed the watch, remove its events without inotify_rm_watch
+    for (auto it = range.first; it != range.second; it++) {
+        WatchNode *node = it->second;
+        node->e->setPending(false);
+        node->wd = -1;
+        // Do not wait for the end of the window
+        if (node->isPending()) {
+            timerBus->delEvent(node);
+            ready.push_back(node);
+        }
+    }
+    watches.erase(range.first, range.second);
+}
+
+void FileWatchBus::deliver(WatchNode *node) {
+    FileWatchEvent *e = node->e;
+
+    e->events = node->events;
+    e->count = node->count;
+    e->names.swap(node->names);
+    node->events = 0;
+    node->count = 0;
+    node->names.clear();
+    node->cb->onEvent(e);
+}
+
+}  // namespace event
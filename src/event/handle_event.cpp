@@ -23,32 +23,133 @@
 
 namespace event {
 
+/// Bits of the operation in the token
+#define HANDLE_OP_BITS 2
+
+/// Bits of the generation in the token
+#define HANDLE_GEN_BITS (sizeof(uintptr_t) * 8 - HANDLE_OP_BITS - HANDLE_FD_BITS)
+
+/// Minimum bits of the generation, a stale token matches again after 2^bits deletes
+#define HANDLE_GEN_BITS_MIN 14
+
+static_assert(HANDLE_GEN_BITS >= HANDLE_GEN_BITS_MIN,
+    "HandleBus: not enough bits for the generation in the tokens");
+
+thread_local HandleBus *HandleBus::polling = nullptr;
+
 void HandleBus::addEvent(HandleEvent *e, const Callback<HandleEvent> *cb) {
+    HandleEvent::Operation op = e->getOperation();
+    int fd = e->getHandle()->getFd();
+    Slot empty = {};
+
     if (e->isPending()) {
         return;
     }
+    if (fd < 0 || fd >= (1 << HANDLE_FD_BITS)) {
+        throw HandleEventException(e,
+            common::ERR_PERM, "invalid handle");
+    }
+    if (static_cast<size_t>(fd) >= table.size()) {
+        table.resize(fd + 1, empty);
+    }
+    Slot &slot = table[fd];
+    if (slot.events[op]) {
+        throw HandleEventException(e,
+            common::ERR_BUSY, "the operation of the handle was added");
+    }
+    slot.events[op] = e;
     e->setPending(true);
     e->setCb(cb);
-    poll.add(e->getHandle(), getEvent(e->getOperation()),
+    poll.add(e->getHandle(), getEvent(op),
         [] (platform::Poll::Event mode,
             platform::Handle *handle, void *arg) {
-            HandleEvent *e = static_cast<HandleEvent *>(arg);
-            e->getCb()->onEvent(e);
-        }, e);
+            polling->onReady(reinterpret_cast<Token>(arg));
+        }, reinterpret_cast<void *>(makeToken(fd, op, slot.gens[op])));
 }
 
 void HandleBus::delEvent(HandleEvent *e) {
+    HandleEvent::Operation op = e->getOperation();
+    int fd = e->getHandle()->getFd();
+
     if (!e->isPending()) {
         return;
     }
-    poll.del(e->getHandle(), getEvent(e->getOperation()));
+    e->setPending(false);
+    poll.del(e->getHandle(), getEvent(op));
+
+    // Drop the readiness already reported for the event
+    Slot &slot = table[fd];
+    if (slot.events[op] == e) {
+        slot.events[op] = nullptr;
+        slot.gens[op]++;
+    }
 }
 
 int HandleBus::dispatch(int timeout) {
+    HandleBus *prev = polling;
+    HandleEvent *e;
+    Token token;
+
+    polling = this;
     poll.polling(timeout);
+    polling = prev;
+
+    for (std::vector<Token> &queue : ready) {
+        // Size may grow when the callback asks to be called again
+        for (size_t i = 0; i < queue.size(); i++) {
+            token = queue[i];
+            e = lookup(token);
+            if (!e) {
+                continue;
+            }
+            e->more = false;
+            e->count++;
+            e->getCb()->onEvent(e);
+            // Deleted in the callback, the event may have been freed
+            if (lookup(token) != e) {
+                continue;
+            }
+            if (e->more && e->count < e->budget) {
+                queue.push_back(token);
+            }
+        }
+        queue.clear();
+    }
     return -1;
 }
 
+HandleBus::Token HandleBus::makeToken(int fd,
+    HandleEvent::Operation op, u32 gen) {
+    Token mask = (static_cast<Token>(1) << HANDLE_GEN_BITS) - 1;
+    return ((gen & mask) << (HANDLE_FD_BITS + HANDLE_OP_BITS)) |
+        (static_cast<Token>(fd) << HANDLE_OP_BITS) | op;
+}
+
+HandleEvent *HandleBus::lookup(Token token) const {
+    size_t fd = (token >> HANDLE_OP_BITS) & ((1 << HANDLE_FD_BITS) - 1);
+    HandleEvent::Operation op = static_cast<HandleEvent::Operation>(
+        token & ((1 << HANDLE_OP_BITS) - 1));
+
+    if (fd >= table.size()) {
+        return nullptr;
+    }
+    const Slot &slot = table[fd];
+    if (makeToken(fd, op, slot.gens[op]) != token) {
+        return nullptr;
+    }
+    return slot.events[op];
+}
+
+void HandleBus::onReady(Token token) {
+    HandleEvent *e = lookup(token);
+
+    if (!e) {
+        return;
+    }
+    e->count = 0;
+    ready[e->getPriority()].push_back(token);
+}
+
 platform::Poll::Event HandleBus::getEvent(HandleEvent::Operation op) {
     platform::Poll::Event e;
     switch (op) {
@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <event/listener_event.hpp>
+#include <sys/socket.h>
+#include <errno.h>
+#include <common/log.hpp>
+
+namespace event {
+
+class ListenerBus::ListenerNode: public HandleEvent {
+ public:
+    class RetryTimer: public TimerEvent {
+     public:
+        explicit RetryTimer(ListenerNode *node): node(node) {}
+
+        ListenerNode *node;
+    };
+
+    ListenerNode(ListenerEvent *e, const Callback<ListenerEvent> *cb,
+        ListenerNode *next):
+        HandleEvent(e->getHandle(), OP_READ),
+        e(e), cb(cb), paused(false), failing(false), retry(this),
+        next(next) {}
+
+    ListenerEvent *e;
+    const Callback<ListenerEvent> *cb;
+    bool paused;
+    bool failing;
+    RetryTimer retry;
+    ListenerNode *next;
+};
+
+class ListenerBus::Acceptor: public Callback<HandleEvent> {
+ public:
+    explicit Acceptor(ListenerBus *bus): bus(bus) {}
+
+    void onEvent(HandleEvent *e) const override {
+        bus->onReadable(static_cast<ListenerNode *>(e));
+    }
+
+ private:
+    ListenerBus *bus;
+};
+
+class ListenerBus::Retrier: public Callback<TimerEvent> {
+ public:
+    explicit Retrier(ListenerBus *bus): bus(bus) {}
+
+    void onEvent(TimerEvent *e) const override {
+        bus->resume(static_cast<ListenerNode::RetryTimer *>(e)->node);
+    }
+
+ private:
+    ListenerBus *bus;
+};
+
+ListenerBus::ListenerBus(HandleBus *handleBus, TimerBus *timerBus):
+    handleBus(handleBus), timerBus(timerBus), acceptor(new Acceptor(this)),
+    retrier(new Retrier(this)), listenerHead(nullptr) {}
+
+ListenerBus::~ListenerBus() {
+    while (listenerHead) {
+        listenerHead->e->setPending(false);
+        remove(listenerHead);
+    }
+    delete retrier;
+    delete acceptor;
+}
+
+void ListenerBus::addEvent(ListenerEvent *e,
+    const Callback<ListenerEvent> *cb) {
+    if (e->isPending()) {
+        throw ListenerEventException(e,
+            common::ERR_BUSY, "the event was added");
+    }
+    e->setPending(true);
+    e->conns = 0;
+    listenerHead = new ListenerNode(e, cb, listenerHead);
+    handleBus->addEvent(listenerHead, acceptor);
+}
+
+void ListenerBus::delEvent(ListenerEvent *e) {
+    ListenerNode *node;
+
+    if (!e->isPending()) {
+        throw ListenerEventException(e,
+            common::ERR_BUSY, "the event was not added");
+    }
+    e->setPending(false);
+    node = find(e);
+    if (node) {
+        remove(node);
+    }
+}
+
+void ListenerBus::release(ListenerEvent *e, u32 n) {
+    ListenerNode *node;
+
+    e->conns = n < e->conns ? e->conns - n : 0;
+    node = find(e);
+    if (node) {
+        resume(node);
+    }
+}
+
+ListenerBus::ListenerNode *ListenerBus::find(ListenerEvent *e) {
+    ListenerNode *cur;
+
+    for (cur = listenerHead; cur; cur = cur->next) {
+        if (cur->e == e) {
+            return cur;
+        }
+    }
+    return nullptr;
+}
+
+void ListenerBus::remove(ListenerNode *node) {
+    ListenerNode **t = &listenerHead;
+
+    while (*t != node) {
+        t = &(*t)->next;
+    }
+    *t = node->next;
+    if (node->retry.isPending()) {
+        timerBus->delEvent(&node->retry);
+    }
+    if (!node->paused) {
+        handleBus->delEvent(node);
+    }
+    delete node;
+}
+
+void ListenerBus::pause(ListenerNode *node) {
+    if (node->paused) {
+        return;
+    }
+    node->paused = true;
+    handleBus->delEvent(node);
+}
+
+void ListenerBus::resume(ListenerNode *node) {
+    ListenerEvent *e = node->e;
+
+    if (!node->paused || (e->maxConns && e->conns >= e->maxConns)) {
+        return;
+    }
+    if (node->retry.isPending()) {
+        timerBus->delEvent(&node->retry);
+    }
+    node->paused = false;
+    handleBus->addEvent(node, acceptor);
+}
+
+void ListenerBus::onReadable(ListenerNode *node) {
+    ListenerEvent *e = node->e;
+    u32 n = e->budget;
+    int fd;
+
+    if (e->maxConns) {
+        if (e->conns >= e->maxConns) {
+            n = 0;
+        } else if (e->maxConns - e->conns < n) {
+            n = e->maxConns - e->conns;
+        }
+    }
+    e->accepted.clear();
+    while (e->accepted.size() < n) {
+        fd = accept4(e->getHandle()->getFd(), nullptr, nullptr,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            e->accepted.push_back(fd);
+            node->failing = false;
+            continue;
+        }
+        if (errno == EINTR || errno == ECONNABORTED) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        // Log once until a connection is accepted again
+        if (!node->failing) {
+            node->failing = true;
+            log_err("%s(): accept4() failed, errno: %d", __func__, errno);
+        }
+        if (errno == EMFILE || errno == ENFILE ||
+            errno == ENOBUFS || errno == ENOMEM) {
+            // The backlog stays readable, wait for resources
+            pause(node);
+            if (!node->retry.isPending()) {
+                node->retry.setTimeout(LISTENER_RETRY_MS);
+                timerBus->addEvent(&node->retry, retrier);
+            }
+        }
+        break;
+    }
+    e->conns += e->accepted.size();
+
+    // Stop polling the backlog until connections are released
+    if (e->maxConns && e->conns >= e->maxConns) {
+        pause(node);
+    }
+    if (!e->accepted.empty()) {
+        node->cb->onEvent(e);
+    }
+}
+
+}  // namespace event
@@ -24,15 +24,49 @@
 namespace event {
 
 void Loop::start() {
-    int ms;
     if (loop) {
         return;
     }
     loop = true;
     while (loop) {
-        ms = TimerBus::dispatch();
+        runOnce(-1);
+    }
+}
+
+void Loop::runOnce(int timeout) {
+    bool running = loop;
+    Clock *clock;
+    int ms;
+
+    TimerBus::dispatch();
+    PrepareBus::dispatch();
+    // The prepare hooks may add timers
+    ms = TimerBus::getTimeout();
+    // Do not block if exit() was called by a timer or a hook
+    if (!IdleBus::isEmpty() || (running && !loop)) {
+        ms = 0;
+    }
+    if (timeout >= 0 && (ms < 0 || timeout < ms)) {
+        ms = timeout;
+    }
+
+    // A virtual clock jumps to the next timer instead of waiting
+    clock = getClock();
+    if (ms > 0 && clock->isVirtual()) {
+        HandleBus::dispatch(0);
+        clock->advance(ms);
+    } else {
         HandleBus::dispatch(ms);
     }
+    CheckBus::dispatch();
+    IdleBus::dispatch();
+}
+
+int Loop::getTimeout() {
+    if (!IdleBus::isEmpty()) {
+        return 0;
+    }
+    return TimerBus::getTimeout();
 }
 
 void Loop::exit() {
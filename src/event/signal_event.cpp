@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <event/signal_event.hpp>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+/// The number of signals read from the signalfd at a time
+#define SIGNAL_BATCH 16
+
+namespace event {
+
+class SignalBus::Reader: public Callback<HandleEvent> {
+ public:
+    explicit Reader(SignalBus *bus): bus(bus) {}
+
+    void onEvent(HandleEvent *) const override {
+        bus->onReadable();
+    }
+
+ private:
+    SignalBus *bus;
+};
+
+SignalBus::SignalBus(HandleBus *bus): bus(bus), reader(new Reader(this)),
+    handle(nullptr), handleEvent(nullptr) {
+    sigemptyset(&mask);
+    sigemptyset(&blocked);
+}
+
+SignalBus::~SignalBus() {
+    if (handle) {
+        bus->delEvent(handleEvent);
+        delete handleEvent;
+        close(handle->getFd());
+        delete handle;
+        unblock(&mask);
+    }
+    delete reader;
+}
+
+void SignalBus::addEvent(SignalEvent *e, const Callback<SignalEvent> *cb) {
+    sigset_t cur;
+
+    if (e->isPending()) {
+        throw SignalEventException(e,
+            common::ERR_BUSY, "the event was added");
+    }
+    if (!sigismember(&mask, e->getSignal())) {
+        if (sigaddset(&mask, e->getSignal())) {
+            throw SignalEventException(e,
+                common::ERR_PERM, "invalid signal");
+        }
+        // Remember the signals blocked by the application
+        pthread_sigmask(SIG_BLOCK, nullptr, &cur);
+        if (sigismember(&cur, e->getSignal())) {
+            sigaddset(&blocked, e->getSignal());
+        }
+        update();
+    }
+    e->setPending(true);
+    e->received = 0;
+    events.push_back(SignalState(e, cb));
+}
+
+void SignalBus::delEvent(SignalEvent *e) {
+    sigset_t set;
+
+    if (!e->isPending()) {
+        throw SignalEventException(e,
+            common::ERR_BUSY, "the event was not added");
+    }
+    e->setPending(false);
+    for (auto it = events.begin(); it != events.end(); it++) {
+        if (it->e == e) {
+            events.erase(it);
+            break;
+        }
+    }
+    for (const SignalState &s : events) {
+        if (s.e->getSignal() == e->getSignal()) {
+            return;
+        }
+    }
+
+    // The last event of the signal
+    sigdelset(&mask, e->getSignal());
+    update();
+    sigemptyset(&set);
+    sigaddset(&set, e->getSignal());
+    unblock(&set);
+}
+
+void SignalBus::update() {
+    int fd;
+
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    fd = signalfd(handle ? handle->getFd() : -1, &mask,
+        SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        throw common::ObjectException<SignalBus>(this,
+            common::ERR_PERM, "failed to create signalfd");
+    }
+    if (!handle) {
+        handle = new platform::Handle(fd);
+        handleEvent = new HandleEvent(handle, HandleEvent::OP_READ);
+        bus->addEvent(handleEvent, reader);
+    }
+}
+
+void SignalBus::unblock(const sigset_t *set) {
+    struct timespec zero = {0, 0};
+    sigset_t unblocked;
+    int signo;
+
+    sigemptyset(&unblocked);
+    for (signo = 1; signo < NSIG; signo++) {
+        if (!sigismember(set, signo)) {
+            continue;
+        }
+        if (sigismember(&blocked, signo)) {
+            sigdelset(&blocked, signo);
+        } else {
+            sigaddset(&unblocked, signo);
+        }
+    }
+
+    // Discard the pending signals, their default action would run once unblocked
+    while (sigtimedwait(&unblocked, nullptr, &zero) > 0) {}
+    pthread_sigmask(SIG_UNBLOCK, &unblocked, nullptr);
+}
+
+void SignalBus::onReadable() {
+    struct signalfd_siginfo infos[SIGNAL_BATCH];
+    ssize_t len;
+    size_t i, n;
+
+    for (;;) {
+        len = read(handle->getFd(), infos, sizeof(infos));
+        if (len <= 0) {
+            break;
+        }
+        n = len / sizeof(infos[0]);
+        for (i = 0; i < n; i++) {
+            for (const SignalState &s : events) {
+                if (s.e->getSignal() == static_cast<int>(infos[i].ssi_signo)) {
+                    s.e->received++;
+                }
+            }
+        }
+        if (n < SIGNAL_BATCH) {
+            break;
+        }
+    }
+
+    // Deliver once per event with all the signals of the batch,
+    // the callbacks may delete events
+    for (;;) {
+        SignalEvent *e = nullptr;
+        const Callback<SignalEvent> *cb = nullptr;
+        for (const SignalState &s : events) {
+            if (s.e->received) {
+                e = s.e;
+                cb = s.cb;
+                break;
+            }
+        }
+        if (!e) {
+            break;
+        }
+        e->count = e->received;
+        e->received = 0;
+        cb->onEvent(e);
+    }
+}
+
+}  // namespace event
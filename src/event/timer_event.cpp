@@ -20,25 +20,14 @@
  * SOFTWARE.
 */
 #include <event/timer_event.hpp>
+#include <event/trace.hpp>
 #include <common/exception.hpp>
 #include <common/assert.hpp>
 #include <common/log.hpp>
 #include <platform/lock.hpp>
-#include <platform/clock.hpp>
 
 namespace event {
 
-class TimerBus::TimerNode {
- public:
-    explicit TimerNode(TimerEvent *e,
-        const Callback<TimerEvent> *cb, TimerNode *next = nullptr):
-        e(e), next(next), cb(cb) {}
-
-    TimerEvent *e;
-    const Callback<TimerEvent> *cb;
-    TimerNode *next;
-};
-
 void TimerEvent::setTimeout(u32 ms) {
     if (this->isPending()) {
         throw TimerEventException(this, common::ERR_PERM,
@@ -47,49 +36,64 @@ void TimerEvent::setTimeout(u32 ms) {
     if (ms > TIMER_DELAY_MAX) {
         ms = TIMER_DELAY_MAX;
     }
-    timeMs = platform::Clock::Instance().getTotalMs() + ms;
-    if (!timeMs) {
-        timeMs--;
-    }
+    delayMs = ms;
 }
 
 u64 TimerEvent::getTimeMs() const {
     return timeMs;
 }
 
+void TimerBus::setClock(Clock *clock) {
+    int pri;
 
-TimerBus::~TimerBus() {
-    TimerNode *cur;
-    while (timerHead) {
-        cur = timerHead;
-        timerHead = cur->next;
-        delete cur;
+    mutex.lock();
+    for (pri = 0; pri < Event::PRI_NUM; pri++) {
+        if (readyHead[pri]) {
+            break;
+        }
     }
+    if (timerHead || pri < Event::PRI_NUM) {
+        mutex.unlock();
+        throw common::ObjectException<TimerBus>(this,
+            common::ERR_BUSY, "timer events were added");
+    }
+    this->clock = clock;
+    mutex.unlock();
 }
 
 void TimerBus::addEvent(TimerEvent *e, const Callback<TimerEvent> *cb) {
     u64 timeMs;
-    TimerNode **t = &timerHead;
-    timeMs = e->getTimeMs();
+    TimerEvent **t = &timerHead;
     if (e->isPending()) {
         throw TimerEventException(e,
             common::ERR_BUSY, "the event was added");
         return;
     }
+    timeMs = clock->getTotalMs() + e->delayMs;
+    if (!timeMs) {
+        timeMs--;
+    }
+    e->timeMs = timeMs;
     e->setPending(true);
+    if (recorder) {
+        recorder->onAdd(e, clock->getTotalMs());
+    }
     mutex.lock();
     while (*t) {
-        if (TIME_AFTER((*t)->e->getTimeMs(), timeMs)) {
+        if (TIME_AFTER((*t)->getTimeMs(), timeMs)) {
             break;
         }
         t = &(*t)->next;
     }
-    *t = new TimerNode(e, cb, *t);
+    e->cb = cb;
+    e->next = *t;
+    *t = e;
     mutex.unlock();
 }
 
 void TimerBus::delEvent(TimerEvent *e) {
-    TimerNode **t = &timerHead, *cur;
+    bool found;
+    int pri;
 
     if (!e->isPending()) {
         throw TimerEventException(e,
@@ -98,18 +102,31 @@ void TimerBus::delEvent(TimerEvent *e) {
     }
     e->setPending(false);
     mutex.lock();
-    while (*t) {
-        cur = *t;
-        if (&(cur->e) == &e) {
-            *t = cur->next;
-            mutex.unlock();
-            delete cur;
-            return;
-        }
+    // The event may be expired and waiting to be dispatched
+    found = unlink(&timerHead, e);
+    for (pri = 0; !found && pri < Event::PRI_NUM; pri++) {
+        found = unlink(&readyHead[pri], e);
     }
     mutex.unlock();
-    throw TimerEventException(e,
-        common::ERR_PERM, "the event was not found");
+    if (!found) {
+        throw TimerEventException(e,
+            common::ERR_PERM, "the event was not found");
+    }
+    if (recorder) {
+        recorder->onDel(e, clock->getTotalMs());
+    }
+}
+
+bool TimerBus::unlink(TimerEvent **list, TimerEvent *e) {
+    while (*list) {
+        if (*list == e) {
+            *list = e->next;
+            e->next = nullptr;
+            return true;
+        }
+        list = &(*list)->next;
+    }
+    return false;
 }
 
 int TimerBus::dispatch() {
@@ -117,30 +134,83 @@ int TimerBus::dispatch() {
 }
 
 int TimerBus::timerAdvance() {
-    TimerEvent *curEvt;
-    const Callback<TimerEvent> *curCb;
-    TimerNode *cur;
-    u64 curMs, tmpMs;
+    TimerEvent **tail[Event::PRI_NUM];
+    TimerEvent *cur;
+    u64 curMs;
+    int pri;
 
+    // Move the expired timers to the ready lists of their priorities
+    curMs = clock->getTotalMs();
+    mutex.lock();
+    for (pri = 0; pri < Event::PRI_NUM; pri++) {
+        tail[pri] = &readyHead[pri];
+    }
     while (timerHead) {
-        mutex.lock();
         cur = timerHead;
-        curEvt = cur->e;
-        curCb = cur->cb;
-        mutex.unlock();
-        tmpMs = curEvt->getTimeMs();
-        curMs = platform::Clock::Instance().getTotalMs();
-        if (TIME_AFTER(tmpMs, curMs)) {
-            return static_cast<int>(tmpMs - curMs);
+        if (TIME_AFTER(cur->getTimeMs(), curMs)) {
+            break;
         }
-        mutex.lock();
         timerHead = cur->next;
+        cur->next = nullptr;
+        pri = cur->getPriority();
+        *tail[pri] = cur;
+        tail[pri] = &cur->next;
+    }
+    mutex.unlock();
+
+    for (pri = 0; pri < Event::PRI_NUM; pri++) {
+        for (;;) {
+            mutex.lock();
+            cur = readyHead[pri];
+            if (!cur) {
+                mutex.unlock();
+                break;
+            }
+            readyHead[pri] = cur->next;
+            cur->next = nullptr;
+            mutex.unlock();
+            cur->setPending(false);
+            if (recorder) {
+                recorder->onFire(cur, curMs);
+            }
+            cur->cb->onEvent(cur);
+        }
+    }
+
+    return getTimeout();
+}
+
+int TimerBus::getTimeout() {
+    u64 tmpMs, curMs;
+    int pri;
+
+    mutex.lock();
+    for (pri = 0; pri < Event::PRI_NUM; pri++) {
+        if (readyHead[pri]) {
+            mutex.unlock();
+            return 0;
+        }
+    }
+    mutex.unlock();
+    if (!getNextTimeMs(&tmpMs)) {
+        return -1;
+    }
+    curMs = clock->getTotalMs();
+    if (!TIME_AFTER(tmpMs, curMs)) {
+        return 0;
+    }
+    return static_cast<int>(tmpMs - curMs);
+}
+
+bool TimerBus::getNextTimeMs(u64 *ms) {
+    mutex.lock();
+    if (!timerHead) {
         mutex.unlock();
-        delete cur;
-        curEvt->setPending(false);
-        curCb->onEvent(curEvt);
+        return false;
     }
-    return -1;
+    *ms = timerHead->getTimeMs();
+    mutex.unlock();
+    return true;
 }
 
 }  // namespace event
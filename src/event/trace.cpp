@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2020 KNpTrue
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#include <event/trace.hpp>
+#include <cstring>
+#include <memory>
+
+/// The magic of the trace file
+#define TRACE_MAGIC "EVTR"
+
+/// The version of the trace file
+#define TRACE_VERSION 1
+
+/// Flush the buffer when it reaches the size
+#define TRACE_BUF_SIZE 65536
+
+namespace event {
+
+/**
+ * @enum The type of the trace record
+*/
+enum TraceRecordType {
+    TRACE_ADD = 1,      ///< the timer was added
+    TRACE_DEL,          ///< the timer was deleted
+    TRACE_FIRE,         ///< the timer was fired
+};
+
+/// Count the fired timers during the replay
+class TraceCounter: public Callback<TimerEvent> {
+ public:
+    TraceCounter(): fired(0) {}
+
+    void onEvent(TimerEvent *) const override {
+        fired++;
+    }
+
+    mutable u64 fired;
+};
+
+TraceRecorder::TraceRecorder(const char *path):
+    nextId(0), lastMs(0), started(false) {
+    fp = fopen(path, "wb");
+    if (!fp) {
+        throw TraceRecorderException(this,
+            common::ERR_PERM, "failed to open the trace file");
+    }
+    buf.reserve(TRACE_BUF_SIZE);
+    buf.insert(buf.end(), TRACE_MAGIC, TRACE_MAGIC + strlen(TRACE_MAGIC));
+    buf.push_back(TRACE_VERSION);
+}
+
+TraceRecorder::~TraceRecorder() {
+    flush();
+    fclose(fp);
+}
+
+void TraceRecorder::onAdd(const TimerEvent *e, u64 ms) {
+    putRecord(TRACE_ADD, e, ms);
+    putVarint(e->getTimeout());
+    buf.push_back(static_cast<u8>(e->getPriority()));
+    if (buf.size() >= TRACE_BUF_SIZE) {
+        flush();
+    }
+}
+
+void TraceRecorder::onDel(const TimerEvent *e, u64 ms) {
+    putRecord(TRACE_DEL, e, ms);
+    putId(e);
+}
+
+void TraceRecorder::onFire(const TimerEvent *e, u64 ms) {
+    putRecord(TRACE_FIRE, e, ms);
+    putId(e);
+}
+
+void TraceRecorder::flush() {
+    if (buf.empty()) {
+        return;
+    }
+    fwrite(buf.data(), 1, buf.size(), fp);
+    fflush(fp);
+    buf.clear();
+}
+
+u32 TraceRecorder::getId(const TimerEvent *e) {
+    auto it = ids.find(e);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    u32 id;
+    if (freeIds.empty()) {
+        id = nextId++;
+    } else {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    ids[e] = id;
+    return id;
+}
+
+void TraceRecorder::putId(const TimerEvent *e) {
+    // The timer is done, its address and ID may be reused by another timer
+    auto it = ids.find(e);
+    if (it != ids.end()) {
+        freeIds.push_back(it->second);
+        ids.erase(it);
+    }
+}
+
+void TraceRecorder::putRecord(u8 type, const TimerEvent *e, u64 ms) {
+    if (!started) {
+        started = true;
+        lastMs = ms;
+    }
+    buf.push_back(type);
+    putVarint(ms > lastMs ? ms - lastMs : 0);
+    putVarint(getId(e));
+    if (ms > lastMs) {
+        lastMs = ms;
+    }
+    if (buf.size() >= TRACE_BUF_SIZE) {
+        flush();
+    }
+}
+
+void TraceRecorder::putVarint(u64 val) {
+    while (val >= 0x80) {
+        buf.push_back(static_cast<u8>(val | 0x80));
+        val >>= 7;
+    }
+    buf.push_back(static_cast<u8>(val));
+}
+
+TraceReplayer::TraceReplayer(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    u8 tmp[4096];
+    size_t n;
+
+    if (!fp) {
+        throw TraceReplayerException(this,
+            common::ERR_PERM, "failed to open the trace file");
+    }
+    while ((n = fread(tmp, 1, sizeof(tmp), fp)) > 0) {
+        data.insert(data.end(), tmp, tmp + n);
+    }
+    fclose(fp);
+    if (data.size() <= strlen(TRACE_MAGIC) ||
+        memcmp(data.data(), TRACE_MAGIC, strlen(TRACE_MAGIC)) ||
+        data[strlen(TRACE_MAGIC)] != TRACE_VERSION) {
+        throw TraceReplayerException(this,
+            common::ERR_PERM, "invalid trace file");
+    }
+}
+
+u64 TraceReplayer::replay(TimerBus *bus, VirtualClock *clock) {
+    size_t begin = strlen(TRACE_MAGIC) + 1, pos;
+    u64 ms = 0, delta, id, timeout, count = 0;
+    TraceCounter counter;
+    u8 type;
+
+    // The IDs are dense, find the number of timers first
+    for (pos = begin; pos < data.size();) {
+        type = data[pos++];
+        if (!getVarint(&pos, &delta) || !getVarint(&pos, &id)) {
+            break;
+        }
+        if (type == TRACE_ADD) {
+            if (!getVarint(&pos, &timeout) || pos >= data.size()) {
+                break;
+            }
+            pos++;
+        }
+        // Each record takes several bytes, a larger ID is corrupt
+        if (id >= data.size()) {
+            break;
+        }
+        if (id >= count) {
+            count = id + 1;
+        }
+    }
+    std::unique_ptr<TimerEvent[]> timers(new TimerEvent[count]);
+
+    clock->setTotalMs(0);
+    bus->setClock(clock);
+    for (pos = begin; pos < data.size();) {
+        type = data[pos++];
+        if (!getVarint(&pos, &delta) || !getVarint(&pos, &id) ||
+            id >= count) {
+            break;
+        }
+        ms += delta;
+        advance(bus, clock, ms);
+        TimerEvent *e = &timers[id];
+        switch (type) {
+        case TRACE_ADD:
+            if (!getVarint(&pos, &timeout) || pos >= data.size()) {
+                break;
+            }
+            if (e->isPending()) {
+                bus->delEvent(e);
+            }
+            e->setPriority(static_cast<Event::Priority>(
+                data[pos++] % Event::PRI_NUM));
+            e->setTimeout(static_cast<u32>(timeout));
+            bus->addEvent(e, &counter);
+            break;
+        case TRACE_DEL:
+            if (e->isPending()) {
+                bus->delEvent(e);
+            }
+            break;
+        default:
+            // Fired by the bus when the clock reached the time
+            break;
+        }
+    }
+
+    // The recording stopped at the last record, the timers left never fired
+    for (id = 0; id < count; id++) {
+        if (timers[id].isPending()) {
+            bus->delEvent(&timers[id]);
+        }
+    }
+    return counter.fired;
+}
+
+bool TraceReplayer::getVarint(size_t *pos, u64 *val) const {
+    u32 shift = 0;
+    u8 byte;
+
+    *val = 0;
+    do {
+        if (*pos >= data.size() || shift >= 64) {
+            return false;
+        }
+        byte = data[(*pos)++];
+        *val |= static_cast<u64>(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return true;
+}
+
+void TraceReplayer::advance(TimerBus *bus, VirtualClock *clock, u64 ms) {
+    int wait;
+
+    for (;;) {
+        wait = bus->dispatch();
+        if (wait < 0 || ms - clock->getTotalMs() < static_cast<u64>(wait)) {
+            break;
+        }
+        clock->advance(wait);
+    }
+    clock->setTotalMs(ms);
+}
+
+}  // namespace event